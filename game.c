@@ -0,0 +1,113 @@
+#include "game.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+const struct game_rules default_game_rules = {.hit_speedup = 15,
+                                              .spin_factor = 4,
+                                              .max_yspeed = 400,
+                                              .max_xspeed = 4000};
+
+static inline int clamp(int val, int min, int max) {
+  if (val < min)
+    return min;
+  if (val > max)
+    return max;
+  return val;
+}
+
+void collide(int16_t *speed, int16_t *pos, int16_t min_pos, int16_t max_pos) {
+  if (*pos > max_pos) {
+    *pos = 2 * max_pos - *pos;
+    *speed *= -1;
+  } else if (*pos < min_pos) {
+    *pos = 2 * min_pos - *pos;
+    *speed *= -1;
+  }
+}
+
+void body_move(struct body *body, uint16_t screen_width, uint16_t screen_height,
+               double delta) {
+  const double screen_resolution_multiplier = (double)screen_width / 1000.;
+  body->x += body->xspeed * screen_resolution_multiplier * delta;
+  body->y += body->yspeed * screen_resolution_multiplier * delta;
+  collide(&body->yspeed, &body->y, 0, screen_height - body->height);
+}
+
+void game_reset(struct game *game) {
+  game->ball.x = game->screen_width / 2 - game->ball.width / 2;
+  game->ball.y = game->screen_height / 2 - game->ball.height / 2;
+  game->ball.xspeed = 170;
+  game->ball.yspeed = 170;
+
+  /* The paddles start 1 pixel down from the top because putting the left window
+   * at (0, 0) causes it to teleport to center after pressing b twice before
+   * moving the window (at least on my machine ¯\_(ツ)_/¯) */
+  game->left_paddle.x = 0;
+  game->left_paddle.y = 1;
+  game->right_paddle.x = game->screen_width - game->right_paddle.width;
+  game->right_paddle.y = 1;
+  game->left_paddle.xspeed = game->left_paddle.yspeed = 0;
+  game->right_paddle.xspeed = game->right_paddle.yspeed = 0;
+
+  game->lost = false;
+}
+
+/* Speeds up the ball and adds spin depending on where it hit the paddle */
+static void bounce(struct body *ball, const struct body *paddle,
+                   const struct game_rules *rules, int16_t speedup) {
+  /* Make the game advance faster. The speeds are calculated as ints and
+   * clamped so that they can't wrap around. */
+  ball->xspeed =
+      clamp(ball->xspeed + speedup, -rules->max_xspeed, rules->max_xspeed);
+
+  ball->yspeed = clamp(
+      ball->yspeed +
+          ((ball->y + ball->height / 2) - (paddle->y + paddle->height / 2)) *
+              rules->spin_factor,
+      -rules->max_yspeed, rules->max_yspeed);
+}
+
+enum game_event game_step(struct game *game, const struct game_rules *rules,
+                          double delta) {
+  struct body *const ball = &game->ball;
+  const struct body *const left_paddle = &game->left_paddle;
+  const struct body *const right_paddle = &game->right_paddle;
+  enum game_event event = GAME_NO_EVENT;
+
+  body_move(&game->left_paddle, game->screen_width, game->screen_height, delta);
+  body_move(&game->right_paddle, game->screen_width, game->screen_height,
+            delta);
+  body_move(ball, game->screen_width, game->screen_height, delta);
+
+  if (ball->x < left_paddle->x + left_paddle->width) {
+    if (!game->lost && ball->y + ball->height > left_paddle->y &&
+        ball->y < left_paddle->y + left_paddle->height) {
+      collide(&ball->xspeed, &ball->x, left_paddle->x + left_paddle->width,
+              INT16_MAX);
+      bounce(ball, left_paddle, rules, rules->hit_speedup);
+      event = GAME_LEFT_HIT;
+    } else {
+      game->lost = true;
+    }
+  } else if (ball->x + ball->width > right_paddle->x) {
+    if (!game->lost && ball->y + ball->height > right_paddle->y &&
+        ball->y < right_paddle->y + right_paddle->height) {
+      collide(&ball->xspeed, &ball->x, INT16_MIN,
+              right_paddle->x - ball->width);
+      bounce(ball, right_paddle, rules, -rules->hit_speedup);
+      event = GAME_RIGHT_HIT;
+    } else {
+      game->lost = true;
+    }
+  } else {
+    game->lost = false;
+  }
+
+  if (ball->x < 0) {
+    return GAME_RIGHT_WINS;
+  } else if (ball->x > game->screen_width - ball->width) {
+    return GAME_LEFT_WINS;
+  }
+  return event;
+}
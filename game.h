@@ -0,0 +1,65 @@
+#ifndef XCB_PONG_GAME_H_
+#define XCB_PONG_GAME_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Position, size and speed of one of the game's windows */
+struct body {
+  int16_t x;
+  int16_t y;
+  uint16_t width;
+  uint16_t height;
+  int16_t xspeed;
+  int16_t yspeed;
+};
+
+/* Physics constants that affect how the game plays */
+struct game_rules {
+  /* Added to the ball's horizontal speed on every paddle hit */
+  int16_t hit_speedup;
+  /* Multiplier for the distance between the ball's and the paddle's centers
+   * that is added to the ball's vertical speed on a hit */
+  int16_t spin_factor;
+  /* Maximum absolute vertical speed of the ball after a hit */
+  int16_t max_yspeed;
+  /* Maximum absolute horizontal speed of the ball after a hit */
+  int16_t max_xspeed;
+};
+
+extern const struct game_rules default_game_rules;
+
+struct game {
+  struct body left_paddle;
+  struct body ball;
+  struct body right_paddle;
+  uint16_t screen_width;
+  uint16_t screen_height;
+  /* Set when the ball has passed a paddle, so that the paddle can't hit it
+   * from behind */
+  bool lost;
+};
+
+enum game_event {
+  GAME_NO_EVENT,
+  GAME_LEFT_HIT,
+  GAME_RIGHT_HIT,
+  GAME_LEFT_WINS,
+  GAME_RIGHT_WINS
+};
+
+void collide(int16_t *speed, int16_t *pos, int16_t min_pos, int16_t max_pos);
+
+/* Moves the body and calculates collisions with the top and bottom edges of
+ * the screen */
+void body_move(struct body *body, uint16_t screen_width, uint16_t screen_height,
+               double delta);
+
+/* Puts the ball in the middle of the screen and the paddles to the top corners
+ * of the screen and resets their speeds. The bodies keep their sizes. */
+void game_reset(struct game *game);
+
+/* Advances the game by delta seconds */
+enum game_event game_step(struct game *game, const struct game_rules *rules,
+                          double delta);
+#endif
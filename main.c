@@ -1,5 +1,7 @@
 #define _POSIX_C_SOURCE 200809L
 
+#include "game.h"
+#include "realtime.h"
 #include "window.h"
 
 #include <errno.h>
@@ -19,14 +21,6 @@
 
 #define ARR_LEN(arr) (sizeof arr / sizeof arr[0])
 
-static inline int16_t clamp(int16_t val, int16_t min, int16_t max) {
-  if (val < min)
-    return min;
-  if (val > max)
-    return max;
-  return val;
-}
-
 static const char *const atom_names[] = {
     [PROTOCOL_ATOM] = "WM_PROTOCOLS",
     [DELETE_WINDOW_ATOM] = "WM_DELETE_WINDOW",
@@ -129,13 +123,22 @@ static void usage(const char *command_name) {
           "\t[-bc {color}]\n"
           "\t[-rc {color}]\n"
           "\t[-fps {number}]\n"
+          "\t[-rounds {number}]\n"
           "\t[-borders]\n"
-          "\t[+borders]\n",
+          "\t[+borders]\n"
+          "\t[-rt]\n"
+          "\t[-timerslack {nanoseconds}]\n"
+          "\t[-cpu {number}]\n"
+          "\t[-mlock]\n"
+          "\t[-jitter]\n",
           command_name);
 }
 
 static uint32_t fps = 30;
+static unsigned long rounds = 1;
 static bool start_borders = true;
+static struct realtime_options realtime_options = {.cpu = -1};
+static bool report_jitter = false;
 
 static int parse_options(int argc, char *argv[]) {
   int return_code = 0;
@@ -176,6 +179,81 @@ static int parse_options(int argc, char *argv[]) {
       }
       goto next_arg;
     }
+    if (strcmp(argv[i], "-rounds") == 0) {
+      if (i == argc - 1) {
+        fputs("missing argument from the last option\n", stderr);
+        return_code = 1;
+      } else {
+        errno = 0;
+        long r = strtol(argv[++i], NULL, 10);
+        if (errno) {
+          fprintf(stderr,
+                  "Failed to parse the number of rounds: %s; using the default "
+                  "value (1)\n",
+                  strerror(errno));
+          goto next_arg;
+        }
+        if (r < 1) {
+          fputs("Invalid number of rounds; using the default value (1)\n",
+                stderr);
+          goto next_arg;
+        }
+        rounds = r;
+      }
+      goto next_arg;
+    }
+    if (strcmp(argv[i], "-timerslack") == 0) {
+      if (i == argc - 1) {
+        fputs("missing argument from the last option\n", stderr);
+        return_code = 1;
+      } else {
+        errno = 0;
+        long slack = strtol(argv[++i], NULL, 10);
+        if (errno) {
+          fprintf(stderr, "Failed to parse timer slack: %s; ignoring it\n",
+                  strerror(errno));
+          goto next_arg;
+        }
+        if (slack < 1) {
+          fputs("Invalid timer slack; ignoring it\n", stderr);
+          goto next_arg;
+        }
+        realtime_options.timer_slack = slack;
+      }
+      goto next_arg;
+    }
+    if (strcmp(argv[i], "-cpu") == 0) {
+      if (i == argc - 1) {
+        fputs("missing argument from the last option\n", stderr);
+        return_code = 1;
+      } else {
+        errno = 0;
+        long cpu = strtol(argv[++i], NULL, 10);
+        if (errno) {
+          fprintf(stderr, "Failed to parse CPU number: %s; ignoring it\n",
+                  strerror(errno));
+          goto next_arg;
+        }
+        if (cpu < 0 || cpu >= 1024) {
+          fputs("Invalid CPU number; ignoring it\n", stderr);
+          goto next_arg;
+        }
+        realtime_options.cpu = cpu;
+      }
+      goto next_arg;
+    }
+    if (strcmp(argv[i], "-rt") == 0) {
+      realtime_options.realtime = true;
+      goto next_arg;
+    }
+    if (strcmp(argv[i], "-mlock") == 0) {
+      realtime_options.lock_memory = true;
+      goto next_arg;
+    }
+    if (strcmp(argv[i], "-jitter") == 0) {
+      report_jitter = true;
+      goto next_arg;
+    }
     /* These are "swapped" like many xeyes options are */
     if (strcmp(argv[i], "-borders") == 0) {
       start_borders = true;
@@ -191,6 +269,21 @@ static int parse_options(int argc, char *argv[]) {
   return return_code;
 }
 
+/* Shows the score in the window titles. Doesn't flush the connection. */
+static void send_score(const struct moving_window *left_paddle,
+                       const struct moving_window *ball,
+                       const struct moving_window *right_paddle,
+                       xcb_connection_t *connection, unsigned long left_score,
+                       unsigned long right_score) {
+  char name[64];
+  snprintf(name, sizeof name, "Xwinpong %lu - %lu", left_score, right_score);
+  moving_window_set_name(ball, connection, name);
+  snprintf(name, sizeof name, "Left paddle: %lu", left_score);
+  moving_window_set_name(left_paddle, connection, name);
+  snprintf(name, sizeof name, "Right paddle: %lu", right_score);
+  moving_window_set_name(right_paddle, connection, name);
+}
+
 static int check_connection_error(xcb_connection_t *connection) {
   int error = xcb_connection_has_error(connection);
   if (error) {
@@ -296,28 +389,31 @@ int main(int argc, char *argv[]) {
     free(atom_reply);
   }
 
-  /* Create the ball */
-  int16_t ball_startx = screen->width_in_pixels / 2 - 150 / 2;
-  int16_t ball_starty = screen->height_in_pixels / 2 - 150 / 2;
+  struct game game = {.left_paddle = {.width = 150, .height = 150},
+                      .ball = {.width = 150, .height = 150},
+                      .right_paddle = {.width = 150, .height = 150},
+                      .screen_width = screen->width_in_pixels,
+                      .screen_height = screen->height_in_pixels};
+  game_reset(&game);
+
   struct moving_window ball =
       moving_window_create(connection, screen, window_colors[BALL],
-                           start_borders, ball_startx, ball_starty);
-  ball.xspeed = 170;
-  ball.yspeed = 170;
-
-  /* The paddles start 1 pixel down from the top because putting the left window
-   * at (0, 0) causes it to teleport to center after pressing b twice before
-   * moving the window (at least on my machine ¯\_(ツ)_/¯) */
-  struct moving_window left_paddle = moving_window_create(
-      connection, screen, window_colors[LEFT_PADDLE], start_borders, 0, 1);
+                           start_borders, &game.ball);
+  struct moving_window left_paddle =
+      moving_window_create(connection, screen, window_colors[LEFT_PADDLE],
+                           start_borders, &game.left_paddle);
   struct moving_window right_paddle =
       moving_window_create(connection, screen, window_colors[RIGHT_PADDLE],
-                           start_borders, screen->width_in_pixels - 150, 1);
+                           start_borders, &game.right_paddle);
 
   moving_window_setup(&ball, connection, atoms, "Xwinpong");
   moving_window_setup(&left_paddle, connection, atoms, "Left paddle");
   moving_window_setup(&right_paddle, connection, atoms, "Right paddle");
 
+  if (rounds > 1) {
+    send_score(&left_paddle, &ball, &right_paddle, connection, 0, 0);
+  }
+
   xcb_map_window(connection, ball.window);
   xcb_map_window(connection, left_paddle.window);
   xcb_map_window(connection, right_paddle.window);
@@ -325,8 +421,14 @@ int main(int argc, char *argv[]) {
   xcb_flush(connection);
 
   const double delta = 1. / fps;
-  bool lost = false;
   bool paused = false;
+  unsigned long left_score = 0;
+  unsigned long right_score = 0;
+  struct frame_jitter jitter = {.frames = 0};
+
+  /* This is done right before the frame loop so that the connection's buffers
+   * are already allocated when memory is locked */
+  realtime_apply(&realtime_options);
   int exit_code = EXIT_SUCCESS;
 
   for (;;) {
@@ -379,17 +481,17 @@ int main(int argc, char *argv[]) {
           switch (keysym) {
           case XK_w:
           case XK_W:
-            left_paddle.yspeed -= 100;
+            game.left_paddle.yspeed -= 100;
             break;
           case XK_s:
           case XK_S:
-            left_paddle.yspeed += 100;
+            game.left_paddle.yspeed += 100;
             break;
           case XK_Up:
-            right_paddle.yspeed -= 100;
+            game.right_paddle.yspeed -= 100;
             break;
           case XK_Down:
-            right_paddle.yspeed += 100;
+            game.right_paddle.yspeed += 100;
             break;
           case XK_p:
           case XK_P:
@@ -452,19 +554,19 @@ int main(int argc, char *argv[]) {
          * traffic, but I want to handle DestroyNotify properly. */
         xcb_configure_notify_event_t *cn =
             (xcb_configure_notify_event_t *)event;
-        struct moving_window *changed_window = NULL;
+        struct body *changed_body = NULL;
         if (cn->window == left_paddle.window) {
-          changed_window = &left_paddle;
+          changed_body = &game.left_paddle;
         } else if (cn->window == right_paddle.window) {
-          changed_window = &right_paddle;
+          changed_body = &game.right_paddle;
           /* TODO: use something better for resizing the right paddle */
-          changed_window->x = screen->width_in_pixels - cn->width;
+          changed_body->x = screen->width_in_pixels - cn->width;
         } else if (cn->window == ball.window) {
-          changed_window = &ball;
+          changed_body = &game.ball;
         }
-        if (changed_window != NULL) {
-          changed_window->width = cn->width;
-          changed_window->height = cn->height;
+        if (changed_body != NULL) {
+          changed_body->width = cn->width;
+          changed_body->height = cn->height;
         }
       } break;
       default:
@@ -478,49 +580,32 @@ int main(int argc, char *argv[]) {
       goto end;
     }
 
-    moving_window_move(&left_paddle, screen, delta);
-    moving_window_move(&right_paddle, screen, delta);
-    moving_window_move(&ball, screen, delta);
-
-    /* TODO: try to deduplicate this code or make it more beautiful */
-    if (ball.x < left_paddle.x + left_paddle.width) {
-      if (!lost && ball.y + ball.height > left_paddle.y &&
-          ball.y < left_paddle.y + left_paddle.height) {
-        collide(&ball.xspeed, &ball.x, left_paddle.x + left_paddle.width,
-                INT16_MAX);
-        /* Make the game advance faster */
-        ball.xspeed += 15;
-
-        ball.yspeed += ((ball.y + ball.height / 2) -
-                        (left_paddle.y + left_paddle.height / 2)) *
-                       4;
-        ball.yspeed = clamp(ball.yspeed, -400, 400);
-      } else {
-        lost = true;
+    switch (game_step(&game, &default_game_rules, delta)) {
+    case GAME_RIGHT_WINS:
+      if (++right_score == rounds) {
+        puts("Right wins!");
+        goto end;
       }
-    } else if (ball.x + ball.width > right_paddle.x) {
-      if (!lost && ball.y + ball.height > right_paddle.y &&
-          ball.y < right_paddle.y + right_paddle.height) {
-        collide(&ball.xspeed, &ball.x, INT16_MIN, right_paddle.x - ball.width);
-        ball.xspeed -= 15;
-
-        ball.yspeed += ((ball.y + ball.height / 2) -
-                        (right_paddle.y + right_paddle.height / 2)) *
-                       4;
-        ball.yspeed = clamp(ball.yspeed, -400, 400);
-      } else {
-        lost = true;
+      /* Start the next round on the next frame with the same windows. The new
+       * positions are sent with the rest of this frame's requests. The ball is
+       * served toward the player who lost the point. */
+      game_reset(&game);
+      game.ball.xspeed = -game.ball.xspeed;
+      send_score(&left_paddle, &ball, &right_paddle, connection, left_score,
+                 right_score);
+      break;
+    case GAME_LEFT_WINS:
+      if (++left_score == rounds) {
+        puts("Left wins!");
+        goto end;
       }
-    } else {
-      lost = false;
-    }
-
-    if (ball.x < 0) {
-      puts("Right wins!");
-      goto end;
-    } else if (ball.x > screen->width_in_pixels - ball.width) {
-      puts("Left wins!");
-      goto end;
+      /* game_reset() serves the ball to the right */
+      game_reset(&game);
+      send_score(&left_paddle, &ball, &right_paddle, connection, left_score,
+                 right_score);
+      break;
+    default:
+      break;
     }
 
     moving_window_send_position(&left_paddle, connection);
@@ -532,10 +617,28 @@ int main(int argc, char *argv[]) {
         .tv_sec = 0,
         .tv_nsec = 1000000000. * delta,
     };
-    nanosleep(&wait_time, NULL);
+    if (report_jitter) {
+      struct timespec sleep_start, sleep_end;
+      clock_gettime(CLOCK_MONOTONIC, &sleep_start);
+      nanosleep(&wait_time, NULL);
+      clock_gettime(CLOCK_MONOTONIC, &sleep_end);
+      frame_jitter_add(&jitter,
+                       (int64_t)(sleep_end.tv_sec - sleep_start.tv_sec) *
+                               1000000000 +
+                           (sleep_end.tv_nsec - sleep_start.tv_nsec) -
+                           wait_time.tv_nsec);
+    } else {
+      nanosleep(&wait_time, NULL);
+    }
   }
 
 end:
+  if (rounds > 1) {
+    printf("Score: %lu - %lu\n", left_score, right_score);
+  }
+  if (report_jitter) {
+    frame_jitter_report(&jitter);
+  }
   xcb_disconnect(connection);
   xcb_key_symbols_free(key_syms);
   return exit_code;
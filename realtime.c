@@ -0,0 +1,188 @@
+/* prctl and sched_setaffinity are Linux-specific */
+#define _GNU_SOURCE
+
+#include "realtime.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#define ARR_LEN(arr) (sizeof arr / sizeof arr[0])
+
+/* High enough to preempt normal processes, but low enough not to compete with
+ * interrupt threads and other important real-time threads */
+#define REALTIME_PRIORITY 10
+
+static void apply_realtime(void) {
+  struct sched_param param = {.sched_priority = REALTIME_PRIORITY};
+  if (sched_setscheduler(0, SCHED_FIFO, &param) != 0 && errno == EPERM) {
+#ifdef RLIMIT_RTPRIO
+    /* Unprivileged processes may still use priorities up to RLIMIT_RTPRIO */
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur > 0 &&
+        limit.rlim_cur < REALTIME_PRIORITY) {
+      param.sched_priority = limit.rlim_cur;
+      sched_setscheduler(0, SCHED_FIFO, &param);
+    }
+#endif
+  }
+  const int error = errno;
+
+  if (sched_getscheduler(0) == SCHED_FIFO && sched_getparam(0, &param) == 0) {
+    fprintf(stderr, "-rt: using SCHED_FIFO with priority %d\n",
+            param.sched_priority);
+  } else {
+    fprintf(stderr,
+            "-rt: failed to set SCHED_FIFO: %s; using the default "
+            "scheduler\n",
+            strerror(error));
+  }
+}
+
+static void apply_timer_slack(unsigned long timer_slack) {
+#ifdef __linux__
+  if (prctl(PR_SET_TIMERSLACK, timer_slack, 0, 0, 0) != 0) {
+    fprintf(stderr, "-timerslack: failed to set the timer slack: %s\n",
+            strerror(errno));
+    return;
+  }
+  const int current = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+  if (sched_getscheduler(0) == SCHED_FIFO) {
+    /* The kernel doesn't apply timer slack to real-time threads */
+    fprintf(stderr,
+            "-timerslack: timer slack is %d ns, but it has no effect with "
+            "SCHED_FIFO\n",
+            current);
+  } else if (current >= 0 && (unsigned long)current == timer_slack) {
+    fprintf(stderr, "-timerslack: timer slack is %d ns\n", current);
+  } else {
+    fprintf(stderr,
+            "-timerslack: requested %lu ns, but the timer slack is %d ns\n",
+            timer_slack, current);
+  }
+#else
+  (void)timer_slack;
+  fputs("-timerslack: not supported on this platform\n", stderr);
+#endif
+}
+
+static void apply_cpu(long cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (sched_setaffinity(0, sizeof set, &set) != 0) {
+    fprintf(stderr, "-cpu: failed to run on CPU %ld: %s\n", cpu,
+            strerror(errno));
+    return;
+  }
+  if (sched_getaffinity(0, sizeof set, &set) == 0 && CPU_COUNT(&set) == 1 &&
+      CPU_ISSET(cpu, &set)) {
+    fprintf(stderr, "-cpu: running on CPU %ld\n", cpu);
+  } else {
+    fprintf(stderr, "-cpu: affinity to CPU %ld didn't take effect\n", cpu);
+  }
+#else
+  (void)cpu;
+  fputs("-cpu: not supported on this platform\n", stderr);
+#endif
+}
+
+/* Touches enough stack that the frame loop doesn't page fault when the stack
+ * grows */
+static void prefault_stack(void) {
+  volatile unsigned char stack[256 * 1024];
+  for (size_t i = 0; i < ARR_LEN(stack); i += 4096) {
+    stack[i] = 0;
+  }
+}
+
+static void apply_lock_memory(void) {
+  /* MCL_FUTURE isn't used because it would count every later allocation
+   * against RLIMIT_MEMLOCK, and heap or stack growth would fail near the limit
+   * instead of just not being locked. The stack is faulted in first so that
+   * MCL_CURRENT locks the part the frame loop uses. */
+  prefault_stack();
+  if (mlockall(MCL_CURRENT) != 0) {
+    fprintf(stderr, "-mlock: failed to lock memory: %s\n", strerror(errno));
+#ifdef RLIMIT_MEMLOCK
+    struct rlimit limit;
+    if (errno == ENOMEM && getrlimit(RLIMIT_MEMLOCK, &limit) == 0 &&
+        limit.rlim_cur != RLIM_INFINITY) {
+      fprintf(stderr, "-mlock: RLIMIT_MEMLOCK is %llu bytes\n",
+              (unsigned long long)limit.rlim_cur);
+    }
+#endif
+    return;
+  }
+  fputs("-mlock: current memory locked; memory allocated later isn't locked\n",
+        stderr);
+}
+
+void realtime_apply(const struct realtime_options *options) {
+  if (options->lock_memory) {
+    apply_lock_memory();
+  }
+  if (options->cpu >= 0) {
+    apply_cpu(options->cpu);
+  }
+  /* The scheduler is set first because it affects whether the timer slack
+   * has an effect */
+  if (options->realtime) {
+    apply_realtime();
+  }
+  if (options->timer_slack > 0) {
+    apply_timer_slack(options->timer_slack);
+  }
+}
+
+void frame_jitter_add(struct frame_jitter *jitter, int64_t oversleep_ns) {
+  if (oversleep_ns < 0) {
+    oversleep_ns = 0;
+  }
+  int64_t bucket = oversleep_ns / 10000;
+  if (bucket >= (int64_t)ARR_LEN(jitter->buckets)) {
+    bucket = ARR_LEN(jitter->buckets) - 1;
+  }
+  ++jitter->buckets[bucket];
+  ++jitter->frames;
+  if (oversleep_ns > jitter->max_ns) {
+    jitter->max_ns = oversleep_ns;
+  }
+}
+
+/* Returns the upper bound of the bucket that contains the given percentile in
+ * microseconds */
+static uint32_t frame_jitter_percentile(const struct frame_jitter *jitter,
+                                        uint32_t percentile) {
+  const uint64_t target = ((uint64_t)jitter->frames * percentile + 99) / 100;
+  uint64_t count = 0;
+  for (size_t i = 0; i < ARR_LEN(jitter->buckets); ++i) {
+    count += jitter->buckets[i];
+    if (count >= target) {
+      return (i + 1) * 10;
+    }
+  }
+  return ARR_LEN(jitter->buckets) * 10;
+}
+
+void frame_jitter_report(const struct frame_jitter *jitter) {
+  if (jitter->frames == 0) {
+    return;
+  }
+  fprintf(stderr,
+          "frame oversleep over %" PRIu32 " frames: p50 < %" PRIu32
+          " us, p99 < %" PRIu32 " us, max %" PRId64 " us\n",
+          jitter->frames, frame_jitter_percentile(jitter, 50),
+          frame_jitter_percentile(jitter, 99), jitter->max_ns / 1000);
+}
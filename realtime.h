@@ -0,0 +1,36 @@
+#ifndef XCB_PONG_REALTIME_H_
+#define XCB_PONG_REALTIME_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Opt-in process settings that reduce frame timing jitter */
+struct realtime_options {
+  /* Use SCHED_FIFO */
+  bool realtime;
+  /* Timer slack in nanoseconds, or 0 to keep the default */
+  unsigned long timer_slack;
+  /* CPU to run on, or -1 to keep the default affinity */
+  long cpu;
+  /* Lock and pre-fault the process's memory */
+  bool lock_memory;
+};
+
+/* Applies the requested settings and reports to stderr whether each one took
+ * effect. Failing to apply a setting isn't fatal. */
+void realtime_apply(const struct realtime_options *options);
+
+/* Histogram of how much later than requested the frame sleeps end */
+struct frame_jitter {
+  /* Buckets of 10 microseconds; the last bucket also counts everything
+   * larger */
+  uint32_t buckets[1000];
+  uint32_t frames;
+  int64_t max_ns;
+};
+
+void frame_jitter_add(struct frame_jitter *jitter, int64_t oversleep_ns);
+
+/* Prints the median, 99th percentile and maximum oversleep to stderr */
+void frame_jitter_report(const struct frame_jitter *jitter);
+#endif
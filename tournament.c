@@ -0,0 +1,405 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "game.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Runs bot-vs-bot matches with the game's update logic without connecting to
+ * an X11 server. Every match gets its own RNG seed that only depends on the
+ * base seed and the match number, and the statistics are gathered in match
+ * order after all matches have finished, so the results don't depend on the
+ * number of threads or on how the matches were scheduled. */
+
+static void usage(const char *command_name) {
+  fprintf(stderr,
+          "usage: %s\n"
+          "\t[-matches {number}]\n"
+          "\t[-threads {number}]\n"
+          "\t[-seed {number}]\n"
+          "\t[-fps {number}]\n"
+          "\t[-width {number}]\n"
+          "\t[-height {number}]\n"
+          "\t[-maxtime {seconds}]\n"
+          "\t[-speedup {number}]\n"
+          "\t[-spin {number}]\n"
+          "\t[-maxyspeed {number}]\n"
+          "\t[-maxxspeed {number}]\n",
+          command_name);
+}
+
+static unsigned long match_count = 10000;
+static unsigned long thread_count;
+static uint64_t base_seed = 1;
+static uint32_t fps = 30;
+static uint16_t screen_width = 1920;
+static uint16_t screen_height = 1080;
+/* Matches between good enough bots could go on forever, so they are called a
+ * draw after this many simulated seconds */
+static unsigned long max_time = 60 * 10;
+static struct game_rules rules;
+
+static int parse_number(const char *option, const char *arg, long min,
+                        long max, long *number) {
+  errno = 0;
+  char *end;
+  long n = strtol(arg, &end, 10);
+  if (errno) {
+    fprintf(stderr, "Failed to parse the argument of %s: %s\n", option,
+            strerror(errno));
+    return 1;
+  }
+  if (*arg == '\0' || *end != '\0' || n < min || n > max) {
+    fprintf(stderr, "Invalid argument for %s: %s (must be %ld-%ld)\n", option,
+            arg, min, max);
+    return 1;
+  }
+  *number = n;
+  return 0;
+}
+
+static int parse_options(int argc, char *argv[]) {
+  const struct {
+    const char *name;
+    long min;
+    long max;
+  } options[] = {
+      {"-matches", 1, LONG_MAX},   {"-threads", 1, 1024},
+      {"-seed", 0, LONG_MAX},      {"-fps", 2, 1000},
+      {"-width", 300, INT16_MAX},  {"-height", 150, INT16_MAX},
+      {"-maxtime", 1, 1000000},    {"-speedup", 0, 1000},
+      {"-spin", 0, 100},           {"-maxyspeed", 0, 10000},
+      {"-maxxspeed", 170, INT16_MAX}};
+  long values[sizeof options / sizeof options[0]] = {
+      match_count,      thread_count,      base_seed,
+      fps,              screen_width,      screen_height,
+      max_time,         rules.hit_speedup, rules.spin_factor,
+      rules.max_yspeed, rules.max_xspeed};
+
+  int return_code = 0;
+  for (int i = 1; i < argc; ++i) {
+    size_t j;
+    for (j = 0; j < sizeof options / sizeof options[0]; ++j) {
+      if (strcmp(argv[i], options[j].name) == 0) {
+        break;
+      }
+    }
+    if (j == sizeof options / sizeof options[0]) {
+      fprintf(stderr, "unknown option: %s\n", argv[i]);
+      return_code = 1;
+    } else if (i == argc - 1) {
+      fputs("missing argument from the last option\n", stderr);
+      return_code = 1;
+    } else if (parse_number(argv[i], argv[i + 1], options[j].min,
+                            options[j].max, &values[j])) {
+      ++i;
+      return_code = 1;
+    } else {
+      ++i;
+    }
+  }
+
+  match_count = values[0];
+  thread_count = values[1];
+  base_seed = values[2];
+  fps = values[3];
+  screen_width = values[4];
+  screen_height = values[5];
+  max_time = values[6];
+  rules.hit_speedup = values[7];
+  rules.spin_factor = values[8];
+  rules.max_yspeed = values[9];
+  rules.max_xspeed = values[10];
+  return return_code;
+}
+
+/* The game stores positions and speeds as int16_t and truncates every step to
+ * whole pixels, so some combinations of the options can't be simulated
+ * correctly */
+static int check_physics(void) {
+  const double pixels_per_speed = screen_width / 1000. / fps;
+  /* A paddle's slowest speed is one keyboard step */
+  if (100 * pixels_per_speed < 1) {
+    fprintf(stderr,
+            "-fps %" PRIu32 " is too high for -width %" PRIu16
+            "; slow windows wouldn't move (at most %" PRIu16
+            " fps is supported)\n",
+            fps, screen_width, screen_width / 10);
+    return 1;
+  }
+  if (screen_width + rules.max_xspeed * pixels_per_speed > INT16_MAX) {
+    fputs("-maxxspeed is too high for the -width and -fps; the ball's position "
+          "would overflow\n",
+          stderr);
+    return 1;
+  }
+  const int16_t max_yspeed = rules.max_yspeed > 400 ? rules.max_yspeed : 400;
+  if (screen_height + max_yspeed * pixels_per_speed > INT16_MAX) {
+    fputs("-maxyspeed or -height is too high for the -width and -fps; the "
+          "windows' positions would overflow\n",
+          stderr);
+    return 1;
+  }
+  return 0;
+}
+
+/* splitmix64 */
+static uint64_t rng_next(uint64_t *state) {
+  uint64_t z = (*state += UINT64_C(0x9e3779b97f4a7c15));
+  z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+  return z ^ (z >> 31);
+}
+
+/* How many times per second a bot presses keys on average, independent of the
+ * frame rate */
+#define BOT_REACTIONS_PER_SECOND 15
+
+/* Moves the paddle towards the ball in the same steps as the keyboard
+ * controls. The bot doesn't react on every frame and aims a bit inaccurately,
+ * so it misses sometimes. */
+static void bot_control(struct body *paddle, const struct body *ball,
+                        uint64_t *rng) {
+  if (rng_next(rng) % fps >= BOT_REACTIONS_PER_SECOND) {
+    return;
+  }
+  const int aim = (int)(rng_next(rng) % (paddle->height / 2 + 1)) -
+                  paddle->height / 4;
+  const int target = ball->y + ball->height / 2 + aim;
+  const int center = paddle->y + paddle->height / 2;
+  if (center < target - paddle->height / 4) {
+    if (paddle->yspeed < 400) {
+      paddle->yspeed += 100;
+    }
+  } else if (center > target + paddle->height / 4) {
+    if (paddle->yspeed > -400) {
+      paddle->yspeed -= 100;
+    }
+  } else if (paddle->yspeed > 0) {
+    paddle->yspeed -= 100;
+  } else if (paddle->yspeed < 0) {
+    paddle->yspeed += 100;
+  }
+}
+
+struct match_result {
+  /* GAME_LEFT_WINS, GAME_RIGHT_WINS or GAME_NO_EVENT for a draw */
+  enum game_event winner;
+  unsigned long hits;
+  unsigned long frames;
+  /* Sum of the ball's absolute horizontal speed over all frames */
+  double xspeed_sum;
+  int16_t max_xspeed;
+};
+
+static struct match_result play_match(unsigned long match) {
+  uint64_t rng = base_seed ^ (match * UINT64_C(0xd1b54a32d192ed03));
+  struct game game = {.left_paddle = {.width = 150, .height = 150},
+                      .ball = {.width = 150, .height = 150},
+                      .right_paddle = {.width = 150, .height = 150},
+                      .screen_width = screen_width,
+                      .screen_height = screen_height};
+  game_reset(&game);
+  if (rng_next(&rng) & 1) {
+    game.ball.xspeed *= -1;
+  }
+  if (rng_next(&rng) & 1) {
+    game.ball.yspeed *= -1;
+  }
+
+  const double delta = 1. / fps;
+  const unsigned long max_frames = max_time * fps;
+  struct match_result result = {.winner = GAME_NO_EVENT};
+  while (result.frames < max_frames) {
+    bot_control(&game.left_paddle, &game.ball, &rng);
+    bot_control(&game.right_paddle, &game.ball, &rng);
+    const enum game_event event = game_step(&game, &rules, delta);
+    ++result.frames;
+
+    const int16_t xspeed =
+        game.ball.xspeed < 0 ? -game.ball.xspeed : game.ball.xspeed;
+    result.xspeed_sum += xspeed;
+    if (xspeed > result.max_xspeed) {
+      result.max_xspeed = xspeed;
+    }
+
+    if (event == GAME_LEFT_HIT || event == GAME_RIGHT_HIT) {
+      ++result.hits;
+    } else if (event == GAME_LEFT_WINS || event == GAME_RIGHT_WINS) {
+      result.winner = event;
+      break;
+    }
+  }
+  return result;
+}
+
+/* Every worker owns a range of match numbers. A worker that runs out of work
+ * steals half of the remaining range of another worker. A worker never holds
+ * two locks at the same time. */
+struct worker {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  unsigned long next;
+  unsigned long end;
+  unsigned long id;
+};
+
+static struct worker *workers;
+static struct match_result *results;
+
+static bool take_match(struct worker *worker, unsigned long *match) {
+  pthread_mutex_lock(&worker->lock);
+  if (worker->next < worker->end) {
+    *match = worker->next++;
+    pthread_mutex_unlock(&worker->lock);
+    return true;
+  }
+  pthread_mutex_unlock(&worker->lock);
+
+  for (unsigned long i = 1; i < thread_count; ++i) {
+    struct worker *const victim = &workers[(worker->id + i) % thread_count];
+    pthread_mutex_lock(&victim->lock);
+    const unsigned long remaining = victim->end - victim->next;
+    if (remaining == 0) {
+      pthread_mutex_unlock(&victim->lock);
+      continue;
+    }
+    const unsigned long stolen = (remaining + 1) / 2;
+    victim->end -= stolen;
+    const unsigned long start = victim->end;
+    pthread_mutex_unlock(&victim->lock);
+
+    pthread_mutex_lock(&worker->lock);
+    worker->next = start + 1;
+    worker->end = start + stolen;
+    pthread_mutex_unlock(&worker->lock);
+    *match = start;
+    return true;
+  }
+  return false;
+}
+
+static void *worker_run(void *arg) {
+  struct worker *const worker = arg;
+  unsigned long match;
+  while (take_match(worker, &match)) {
+    results[match] = play_match(match);
+  }
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  rules = default_game_rules;
+  const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  thread_count = cpus > 0 ? cpus : 1;
+  if (parse_options(argc, argv) || check_physics()) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (thread_count > match_count) {
+    thread_count = match_count;
+  }
+
+  workers = calloc(thread_count, sizeof *workers);
+  results = calloc(match_count, sizeof *results);
+  if (workers == NULL || results == NULL) {
+    free(workers);
+    free(results);
+    fputs("Can't allocate space for the matches\n", stderr);
+    return EXIT_FAILURE;
+  }
+
+  struct timespec start_time, end_time;
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+  unsigned long started = 0;
+  for (unsigned long i = 0; i < thread_count; ++i) {
+    workers[i].id = i;
+    workers[i].next = match_count * i / thread_count;
+    workers[i].end = match_count * (i + 1) / thread_count;
+    pthread_mutex_init(&workers[i].lock, NULL);
+  }
+  for (; started < thread_count; ++started) {
+    int error = pthread_create(&workers[started].thread, NULL, worker_run,
+                               &workers[started]);
+    if (error) {
+      /* The other workers steal the work of the missing ones */
+      fprintf(stderr, "Failed to create a thread: %s\n", strerror(error));
+      break;
+    }
+  }
+  if (started == 0) {
+    worker_run(&workers[0]);
+  }
+  for (unsigned long i = 0; i < started; ++i) {
+    pthread_join(workers[i].thread, NULL);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+  const double elapsed = (end_time.tv_sec - start_time.tv_sec) +
+                         (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+
+  unsigned long left_wins = 0, right_wins = 0, draws = 0;
+  unsigned long total_hits = 0, max_hits = 0, total_frames = 0;
+  double xspeed_sum = 0;
+  int16_t max_xspeed = 0;
+  for (unsigned long i = 0; i < match_count; ++i) {
+    const struct match_result *const result = &results[i];
+    switch (result->winner) {
+    case GAME_LEFT_WINS:
+      ++left_wins;
+      break;
+    case GAME_RIGHT_WINS:
+      ++right_wins;
+      break;
+    default:
+      ++draws;
+      break;
+    }
+    total_hits += result->hits;
+    if (result->hits > max_hits) {
+      max_hits = result->hits;
+    }
+    total_frames += result->frames;
+    xspeed_sum += result->xspeed_sum;
+    if (result->max_xspeed > max_xspeed) {
+      max_xspeed = result->max_xspeed;
+    }
+  }
+
+  printf("matches: %lu (seed %" PRIu64 ", %lu threads, %.3f s, %.0f "
+         "matches/s)\n",
+         match_count, base_seed, started ? started : 1, elapsed,
+         match_count / elapsed);
+  printf("rules: speedup %" PRId16 ", spin %" PRId16 ", max yspeed %" PRId16
+         ", max xspeed %" PRId16 "\n",
+         rules.hit_speedup, rules.spin_factor, rules.max_yspeed,
+         rules.max_xspeed);
+  printf("left wins: %lu (%.2f%%)\n", left_wins,
+         100. * left_wins / match_count);
+  printf("right wins: %lu (%.2f%%)\n", right_wins,
+         100. * right_wins / match_count);
+  printf("draws: %lu (%.2f%%)\n", draws, 100. * draws / match_count);
+  printf("rally length: mean %.2f hits, max %lu hits\n",
+         (double)total_hits / match_count, max_hits);
+  printf("match length: mean %.2f s\n",
+         (double)total_frames / match_count / fps);
+  printf("ball horizontal speed: mean %.2f, max %" PRId16 "\n",
+         xspeed_sum / total_frames, max_xspeed);
+
+  for (unsigned long i = 0; i < thread_count; ++i) {
+    pthread_mutex_destroy(&workers[i].lock);
+  }
+  free(workers);
+  free(results);
+  return EXIT_SUCCESS;
+}
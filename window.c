@@ -7,16 +7,6 @@
 #include <xcb/xcb.h>
 #include <xcb/xproto.h>
 
-void collide(int16_t *speed, int16_t *pos, int16_t min_pos, int16_t max_pos) {
-  if (*pos > max_pos) {
-    *pos = 2 * max_pos - *pos;
-    *speed *= -1;
-  } else if (*pos < min_pos) {
-    *pos = 2 * min_pos - *pos;
-    *speed *= -1;
-  }
-}
-
 static xcb_window_t window_create(xcb_connection_t *connection,
                                   const xcb_screen_t *screen, uint32_t color,
                                   bool override_redirect, int16_t x, int16_t y,
@@ -41,6 +31,13 @@ static xcb_window_t window_create(xcb_connection_t *connection,
   return window;
 }
 
+static void window_set_name(xcb_connection_t *connection, xcb_window_t window,
+                            const char *window_name) {
+  xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window,
+                      XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, strlen(window_name),
+                      window_name);
+}
+
 static void window_setup(xcb_connection_t *connection, xcb_window_t window,
                          xcb_atom_t atoms[], const char *window_name) {
   if (atoms[PROTOCOL_ATOM] != XCB_ATOM_NONE &&
@@ -55,9 +52,7 @@ static void window_setup(xcb_connection_t *connection, xcb_window_t window,
                         atoms[WINDOW_TYPE_ATOM], XCB_ATOM_ATOM, 32, 1,
                         &atoms[DIALOG_ATOM]);
   }
-  xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window,
-                      XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, strlen(window_name),
-                      window_name);
+  window_set_name(connection, window, window_name);
   /* TODO: set the instance name in a better way */
   xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window,
                       XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8, 18,
@@ -67,15 +62,15 @@ static void window_setup(xcb_connection_t *connection, xcb_window_t window,
 struct moving_window moving_window_create(xcb_connection_t *connection,
                                           const xcb_screen_t *screen,
                                           uint32_t color, bool borders,
-                                          int16_t x, int16_t y) {
+                                          struct body *body) {
   const xcb_window_t window =
-      window_create(connection, screen, color, false, x, y, 150, 150);
+      window_create(connection, screen, color, false, body->x, body->y,
+                    body->width, body->height);
   const xcb_window_t other_window =
-      window_create(connection, screen, color, true, x, y, 150, 150);
-  return borders ? (struct moving_window){window, other_window, x, y,
-                                          150,    150,          0, 0}
-                 : (struct moving_window){other_window, window, x, y,
-                                          150,          150,    0, 0};
+      window_create(connection, screen, color, true, body->x, body->y,
+                    body->width, body->height);
+  return borders ? (struct moving_window){window, other_window, body}
+                 : (struct moving_window){other_window, window, body};
 }
 
 /* Both windows get the atoms set */
@@ -86,26 +81,23 @@ void moving_window_setup(const struct moving_window *window,
   window_setup(connection, window->other_window, atoms, window_name);
 }
 
-void moving_window_move(struct moving_window *window,
-                        const xcb_screen_t *screen, double delta) {
-  const double screen_resolution_multiplier =
-      (double)screen->width_in_pixels / 1000.;
-  window->x += window->xspeed * screen_resolution_multiplier * delta;
-  window->y += window->yspeed * screen_resolution_multiplier * delta;
-  collide(&window->yspeed, &window->y, 0,
-          screen->height_in_pixels - window->height);
+void moving_window_set_name(const struct moving_window *window,
+                            xcb_connection_t *connection,
+                            const char *window_name) {
+  window_set_name(connection, window->window, window_name);
+  window_set_name(connection, window->other_window, window_name);
 }
 
 void moving_window_send_position(const struct moving_window *window,
                                  xcb_connection_t *connection) {
-  const uint32_t coords[] = {window->x, window->y};
+  const uint32_t coords[] = {window->body->x, window->body->y};
   xcb_configure_window(connection, window->window,
                        XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, coords);
 }
 
 static void moving_window_send_size(const struct moving_window *window,
                                     xcb_connection_t *connection) {
-  const uint32_t size[] = {window->width, window->height};
+  const uint32_t size[] = {window->body->width, window->body->height};
   xcb_configure_window(connection, window->window,
                        XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
                        size);
@@ -1,6 +1,8 @@
 #ifndef XCB_PONG_WINDOW_H_
 #define XCB_PONG_WINDOW_H_
 
+#include "game.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -8,16 +10,12 @@
 #include <xcb/xproto.h>
 
 /* One of the windows has override-redirect set and the other doesn't. window is
- * the mapped window and other_window is the unmapped one. */
+ * the mapped window and other_window is the unmapped one. The position and size
+ * of the windows come from body. */
 struct moving_window {
   xcb_window_t window;
   xcb_window_t other_window;
-  int16_t x;
-  int16_t y;
-  uint16_t width;
-  uint16_t height;
-  int16_t xspeed;
-  int16_t yspeed;
+  struct body *body;
 };
 
 enum atom_type {
@@ -27,22 +25,21 @@ enum atom_type {
   DIALOG_ATOM
 };
 
-void collide(int16_t *speed, int16_t *pos, int16_t min_pos, int16_t max_pos);
-
+/* Both windows are created at the body's position and with its size */
 struct moving_window moving_window_create(xcb_connection_t *connection,
                                           const xcb_screen_t *screen,
                                           uint32_t color, bool borders,
-                                          int16_t x, int16_t y);
+                                          struct body *body);
 
 /* Sets some ICCCM and EWMH atoms for window managers */
 void moving_window_setup(const struct moving_window *window,
                          xcb_connection_t *connection, xcb_atom_t atoms[],
                          const char *window_name);
 
-/* Moves the window and calculates collisions with the top and bottom edges of
- * the screen. Doesn't send X11 requests. */
-void moving_window_move(struct moving_window *window,
-                        const xcb_screen_t *screen, double delta);
+/* Changes the title of both windows */
+void moving_window_set_name(const struct moving_window *window,
+                            xcb_connection_t *connection,
+                            const char *window_name);
 
 void moving_window_send_position(const struct moving_window *window,
                                  xcb_connection_t *connection);